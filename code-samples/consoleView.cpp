@@ -1,5 +1,7 @@
 #include "consoleView.h"
 #include <iostream>
+#include <limits>
+#include <stdexcept>
 
 using std::cin;
 using std::cout;
@@ -15,6 +17,9 @@ void ConsoleView::displayMenu()
     std::cout << "3. Multiplicate a number" << std::endl;
     std::cout << "4. Divide a number" << std::endl;
     std::cout << "5. Reset a number" << std::endl;
+    std::cout << "6. Set a formula" << std::endl;
+    std::cout << "7. Edit a formula" << std::endl;
+    std::cout << "8. Set a plot range" << std::endl;
     std::cout << "0. Quit" << std::endl << std::endl;
 }
 
@@ -34,13 +39,50 @@ double ConsoleView::performNumericInput()
     return number;
 } 
 
+std::size_t ConsoleView::performCountInput()
+{
+    long long number;
+    std::cout << "Input a non-negative integer: ";
+    if (!(std::cin >> number) || number < 0)
+    {
+        std::cin.clear();
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        throw std::invalid_argument("Non-negative integer expected");
+    }
+    return static_cast<std::size_t>(number);
+}
+
+std::string ConsoleView::performStringInput()
+{
+    std::string text;
+    std::cout << "Input a text: ";
+    std::cin >> std::ws;
+    std::getline(std::cin, text);
+    return text;
+}
+
+void ConsoleView::displayPlot()
+{
+    if (!controller->waitPlot())
+    {
+        std::cout << "Plot is not ready" << std::endl;
+        return;
+    }
+
+    const std::vector<double> &grid = controller->getGrid();
+    const std::vector<double> &plot = controller->getPlot();
+    for (std::size_t i = 0; i < plot.size(); i++)
+        std::cout << "f(" << grid[i] << ") = " << plot[i] << std::endl;
+}
+
 void ConsoleView::startEventLoop()
 {
     while (true) 
     {
         double result;
         displayMenu();
-        switch ((Choice)performChoice())
+        Choice choice = (Choice)performChoice();
+        switch (choice)
         {
         case SUM:
             result = controller->add(performNumericInput());
@@ -63,6 +105,35 @@ void ConsoleView::startEventLoop()
             result = 0.0;
             break;
 
+        case FORMULA:
+        case EDIT:
+        case RANGE:
+            try
+            {
+                if (choice == FORMULA)
+                {
+                    controller->setFormula(performStringInput());
+                }
+                else if (choice == EDIT)
+                {
+                    std::size_t position = performCountInput();
+                    std::size_t erased = performCountInput();
+                    controller->editFormula(position, erased, performStringInput());
+                }
+                else
+                {
+                    double x_min = performNumericInput();
+                    double x_max = performNumericInput();
+                    controller->setGrid(x_min, x_max, performCountInput());
+                }
+                displayPlot();
+            }
+            catch (const std::exception &e)
+            {
+                std::cout << e.what() << std::endl;
+            }
+            continue;
+
         case EXIT:
             exit(1);
 
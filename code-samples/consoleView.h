@@ -1,6 +1,8 @@
 #ifndef CONSOLEVIEW_H
 #define CONSOLEVIEW_H
 
+#include <string>
+
 #include "exampleController.h"
 
 enum Choice
@@ -10,6 +12,9 @@ enum Choice
     MUL = 3,
     DIV = 4,
     RES = 5,
+    FORMULA = 6,
+    EDIT = 7,
+    RANGE = 8,
     EXIT = 0,
     NONE = -1
 };
@@ -23,6 +28,9 @@ class ConsoleView
         void displayMenu();
         int performChoice();
         double performNumericInput();
+        std::size_t performCountInput();
+        std::string performStringInput();
+        void displayPlot();
         void startEventLoop();
 };
 
@@ -26,4 +26,59 @@ double ExampleController::div(double a)
 
 void ExampleController::reset(){
     model->reset();
-}
\ No newline at end of file
+}
+
+ExampleController::~ExampleController()
+{
+    cancelEvaluation();
+}
+
+void ExampleController::cancelEvaluation()
+{
+    model->publishVersion();
+    if (evaluation.valid())
+        evaluation.wait();
+}
+
+void ExampleController::startEvaluation()
+{
+    uint64_t version = model->publishVersion();
+    evaluation = std::async(std::launch::async, &ExampleModel::evaluate, model, version);
+}
+
+void ExampleController::setFormula(const std::string &formula)
+{
+    cancelEvaluation();
+    model->setFormula(formula);
+    startEvaluation();
+}
+
+void ExampleController::editFormula(std::size_t position, std::size_t erased,
+        const std::string &inserted)
+{
+    cancelEvaluation();
+    model->editFormula(position, erased, inserted);
+    startEvaluation();
+}
+
+void ExampleController::setGrid(double x_min, double x_max, std::size_t points)
+{
+    cancelEvaluation();
+    model->setGrid(x_min, x_max, points);
+    startEvaluation();
+}
+
+bool ExampleController::waitPlot()
+{
+    return evaluation.valid() && evaluation.get();
+}
+
+const std::vector<double> &ExampleController::getGrid()
+{
+    return model->getGrid();
+}
+
+const std::vector<double> &ExampleController::getPlot()
+{
+    return model->getPlot();
+}
@@ -1,19 +1,32 @@
 #ifndef EXAMPLECONTROLLER_H
 #define EXAMPLECONTROLLER_H
 
+#include <future>
+
 #include "exampleModel.h"
 
 class ExampleController 
 {
     private:
         ExampleModel *model;
+        std::future<bool> evaluation;
+        void cancelEvaluation();
+        void startEvaluation();
     public:
         ExampleController(ExampleModel *m):model(m) {};
+        ~ExampleController();
         double add(double a);
         double sub(double a);
         double mult(double a);
         double div(double a);
         void reset();
+
+        void setFormula(const std::string &formula);
+        void editFormula(std::size_t position, std::size_t erased, const std::string &inserted);
+        void setGrid(double x_min, double x_max, std::size_t points);
+        bool waitPlot();
+        const std::vector<double> &getGrid();
+        const std::vector<double> &getPlot();
 };
 
-#endif
\ No newline at end of file
+#endif
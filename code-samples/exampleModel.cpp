@@ -18,4 +18,43 @@ void ExampleModel::reset()
 double ExampleModel::getData()
 {
     return data;
-}
\ No newline at end of file
+}
+
+uint64_t ExampleModel::publishVersion()
+{
+    return ++version;
+}
+
+void ExampleModel::setFormula(const std::string &formula)
+{
+    program.build(lexer.reset(formula));
+}
+
+void ExampleModel::editFormula(std::size_t position, std::size_t erased,
+        const std::string &inserted)
+{
+    program.build(lexer.edit(position, erased, inserted));
+}
+
+void ExampleModel::setGrid(double x_min, double x_max, std::size_t points)
+{
+    std::vector<double> grid(points);
+    for (std::size_t i = 0; i < points; i++)
+        grid[i] = (points > 1) ? x_min + (x_max - x_min) * i / (points - 1) : x_min;
+    program.setGrid(grid);
+}
+
+bool ExampleModel::evaluate(uint64_t formula_version)
+{
+    return program.evaluate(incremental::EvaluationTicket{version, formula_version});
+}
+
+const std::vector<double> &ExampleModel::getGrid()
+{
+    return program.grid();
+}
+
+const std::vector<double> &ExampleModel::getPlot()
+{
+    return program.samples();
+}
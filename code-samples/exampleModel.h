@@ -1,16 +1,34 @@
 #ifndef EXAMPLEMODEL_H
 #define EXAMPLEMODEL_H
 
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../src/incremental.hpp"
+
 class ExampleModel
 {
     private:
         double data;
+        incremental::IncrementalLexer lexer;
+        incremental::ExpressionGraph program;
+        std::atomic<uint64_t> version;
     public:
-        ExampleModel():data(0){};
+        ExampleModel():data(0),version(0){};
         void add(double a);
         void mult(double a);
         void reset();
         double getData();
+
+        uint64_t publishVersion();
+        void setFormula(const std::string &formula);
+        void editFormula(std::size_t position, std::size_t erased, const std::string &inserted);
+        void setGrid(double x_min, double x_max, std::size_t points);
+        bool evaluate(uint64_t formula_version);
+        const std::vector<double> &getGrid();
+        const std::vector<double> &getPlot();
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -1,5 +1,8 @@
 #include <any>
+#include <cmath>
 #include <functional>
+#include <limits>
+#include <stdexcept>
 #include <variant>
 
 #include <unordered_map>
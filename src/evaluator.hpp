@@ -0,0 +1,134 @@
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <variant>
+
+#include <vector>
+
+#include "calculations.hpp"
+#include "processor.hpp"
+
+#ifndef __EVALUATOR_HPP__
+#define __EVALUATOR_HPP__
+
+namespace calculations {
+/// @brief  Formula compiled from the inverse polish notation of DjkstraProcessor. Evaluates
+/// the whole batch of x values step by step, so every operator is looked up only once.
+class NotationEvaluator {
+    static constexpr std::size_t evaluation_chunk = 4096;
+
+    struct Instruction {
+        enum class Kind : uint8_t { Number, Variable, Unary, Binary };
+
+        Kind kind;
+        double value;
+        Operator action;
+    };
+
+private:
+    std::vector<Instruction> program_;
+    std::size_t depth_ = 0;
+
+    /// @brief  DjkstraProcessor checks only the total of the brackets and pops an empty stack on
+    /// a ')' without its '(', so every prefix of the formula is checked here.
+    static void validateBrackets(const std::string& expression) {
+        int64_t depth = 0;
+        for (char symbol : expression) {
+            if (symbol == '(') depth++;
+            if (symbol == ')' && --depth < 0) {
+                throw preprocess::exceptions::BracketSequenceException(
+                    "Invalid bracket sequence\n");
+            }
+        }
+    }
+
+    void compile(preprocess::DjkstraProcessor& parser, const std::string& expression,
+                 const IAlgebra& algebra) {
+        validateBrackets(expression);
+        std::size_t depth = 0;
+        const Operator stub = default_algebra_rules.at('+');
+
+        for (auto token : parser.inversePolishNotation(expression)) {
+            if (std::holds_alternative<preprocess::Token<double>>(token)) {
+                double value = std::get<preprocess::Token<double>>(token).getData();
+                program_.push_back(Instruction{Instruction::Kind::Number, value, stub});
+                depth++;
+            } else if (std::get<preprocess::Token<char>>(token).getData() == 'x') {
+                program_.push_back(Instruction{Instruction::Kind::Variable, 0, stub});
+                depth++;
+            } else {
+                char symbol = std::get<preprocess::Token<char>>(token).getData();
+                bool is_binary_operator = preprocess::available_operators.count(symbol) != 0;
+                std::size_t arity = (is_binary_operator) ? 2 : 1;
+
+                if (depth < arity) throw std::logic_error("Invalid expression\n");
+                depth -= arity - 1;
+
+                auto kind = (is_binary_operator) ? Instruction::Kind::Binary
+                                                 : Instruction::Kind::Unary;
+                program_.push_back(Instruction{kind, 0, algebra.getRule(symbol)});
+            }
+            depth_ = std::max(depth_, depth);
+        }
+
+        if (depth != 1) throw std::logic_error("Invalid expression\n");
+    }
+
+    void evaluateChunk(const double* x, std::size_t size,
+                       std::vector<std::vector<double>>& stack) const {
+        std::size_t top = 0;
+
+        for (const Instruction& instruction : program_) {
+            switch (instruction.kind) {
+                case Instruction::Kind::Number:
+                    std::fill(stack[top].begin(), stack[top].begin() + size, instruction.value);
+                    top++;
+                    break;
+                case Instruction::Kind::Variable:
+                    std::copy(x, x + size, stack[top].begin());
+                    top++;
+                    break;
+                case Instruction::Kind::Unary:
+                    for (std::size_t i = 0; i < size; i++)
+                        stack[top - 1][i] = instruction.action(stack[top - 1][i]);
+                    break;
+                case Instruction::Kind::Binary:
+                    for (std::size_t i = 0; i < size; i++)
+                        stack[top - 2][i] =
+                            instruction.action(stack[top - 2][i], stack[top - 1][i]);
+                    top--;
+                    break;
+            }
+        }
+    }
+
+public:
+    NotationEvaluator(const std::string& expression, const IAlgebra& algebra) {
+        preprocess::DjkstraProcessor parser;
+        compile(parser, expression, algebra);
+    }
+
+    double operator()(double x) const {
+        std::vector<double> result;
+        evaluate(&x, 1, result);
+        return result.front();
+    }
+
+    /// @brief  Evaluates the formula for `quantity` values of x starting at `x`. The values go
+    /// through the program in chunks, so the stack takes depth * evaluation_chunk doubles at most.
+    void evaluate(const double* x, std::size_t quantity, std::vector<double>& result) const {
+        result.resize(quantity);
+        std::size_t chunk = std::min(quantity, evaluation_chunk);
+        std::vector<std::vector<double>> stack(depth_, std::vector<double>(chunk));
+
+        for (std::size_t begin = 0; begin < quantity; begin += evaluation_chunk) {
+            std::size_t size = std::min(evaluation_chunk, quantity - begin);
+            evaluateChunk(x + begin, size, stack);
+            std::copy(stack.front().begin(), stack.front().begin() + size, result.begin() + begin);
+        }
+    }
+};
+}  // namespace calculations
+
+#endif  // __EVALUATOR_HPP__
@@ -0,0 +1,481 @@
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+
+#include <utility>
+#include <vector>
+
+#ifndef __FINANCE_HPP__
+#define __FINANCE_HPP__
+
+namespace calculations {
+namespace finance {
+/// @brief  Amount of money in minor units (cents). Balances are accumulated in it, so the
+/// rounding happens once per period and never drifts over long schedules.
+using money = int64_t;
+
+/// @brief  Annual rate in millionths (0.12 or 12% is 120000), so interest is computed exactly.
+using rate = int64_t;
+
+inline constexpr int money_digits = 2;
+inline constexpr int rate_digits = 6;
+inline constexpr rate rate_scale = 1000000;
+
+/// @brief  Limits of the loans: (1 + max_rate / 12)^max_term stays far below the double range
+/// and the total paid for max_principal stays far below the money range.
+inline constexpr uint32_t max_term = 1200;
+inline constexpr rate max_rate = 5 * rate_scale;
+inline constexpr money max_principal = 1000000000000000;
+
+/// @brief  Divides rounding half away from zero, `denominator` must be positive.
+inline __int128 divideRounded(__int128 numerator, __int128 denominator) {
+    __int128 quotient = numerator / denominator;
+    __int128 remainder = numerator % denominator;
+    if (2 * (remainder < 0 ? -remainder : remainder) >= denominator)
+        quotient += (numerator < 0) ? -1 : 1;
+    return quotient;
+}
+
+/// @brief  Parses a decimal like "-1.005" or "1.26e-2" into units of 10^-digits, rounding half
+/// away from zero on the decimal digits, so no binary representation error gets in.
+inline int64_t parseDecimal(std::string_view text, int digits) {
+    bool negative = !text.empty() && text.front() == '-';
+    std::size_t position = (!text.empty() && (text.front() == '-' || text.front() == '+')) ? 1 : 0;
+
+    std::string mantissa;
+    int exponent = 0;
+    bool fraction = false;
+    for (; position < text.size(); position++) {
+        char symbol = text[position];
+        if (symbol == '.' && !fraction) {
+            fraction = true;
+        } else if (std::isdigit(static_cast<unsigned char>(symbol))) {
+            mantissa.push_back(symbol);
+            if (fraction) exponent--;
+        } else {
+            break;
+        }
+    }
+    if (position < text.size() && (text[position] == 'e' || text[position] == 'E')) {
+        std::size_t parsed = 0;
+        exponent += std::stoi(std::string(text.substr(position + 1)), &parsed);
+        position += parsed + 1;
+    }
+    if (mantissa.empty() || position != text.size()) {
+        throw std::logic_error("Invalid decimal number\n");
+    }
+
+    int shift = exponent + digits;
+    std::size_t kept = (shift >= 0) ? mantissa.size()
+                       : (-shift >= static_cast<int>(mantissa.size()))
+                           ? 0
+                           : mantissa.size() + shift;
+    __int128 value = 0;
+    for (std::size_t i = 0; i < kept; i++) {
+        value = value * 10 + (mantissa[i] - '0');
+        if (value > std::numeric_limits<int64_t>::max()) break;
+    }
+    for (int i = 0; i < shift && value <= std::numeric_limits<int64_t>::max(); i++) value *= 10;
+    if (kept < mantissa.size() && -shift <= static_cast<int>(mantissa.size()) &&
+        mantissa[kept] >= '5')
+        value++;
+    if (value > std::numeric_limits<int64_t>::max()) {
+        throw std::logic_error("Decimal number is out of range\n");
+    }
+
+    return static_cast<int64_t>((negative) ? -value : value);
+}
+
+/// @brief  Converts through the shortest decimal text which reads back as the same double, so
+/// 1.005 is 100.5 cents rounded to 101 and not the 100.4999... of its binary value.
+inline int64_t parseDecimal(double value, int digits) {
+    if (!std::isfinite(value)) throw std::logic_error("Invalid decimal number\n");
+
+    char text[32];
+    std::to_chars_result written = std::to_chars(text, text + sizeof(text), value);
+    return parseDecimal(std::string_view(text, written.ptr - text), digits);
+}
+
+inline money toMoney(double amount) { return parseDecimal(amount, money_digits); }
+inline money toMoney(std::string_view amount) { return parseDecimal(amount, money_digits); }
+inline double fromMoney(money amount) { return static_cast<double>(amount) / 100; }
+
+/// @brief  Converts the annual rate given as a fraction (0.12 is 12%).
+inline rate toRate(double annual) { return parseDecimal(annual, rate_digits); }
+inline rate toRate(std::string_view annual) { return parseDecimal(annual, rate_digits); }
+
+/// @brief  Interest of one month on the balance, exactly rounded half away from zero.
+inline money monthlyInterest(money balance, rate annual) {
+    return static_cast<money>(
+        divideRounded(static_cast<__int128>(balance) * annual, __int128{12} * rate_scale));
+}
+
+/// @brief  Rounds the amount in minor units half away from zero. Only for the amounts which have
+/// no exact decimal value anyway, like the annuity payment. Throws on NaN, infinity and amounts
+/// which do not fit money.
+inline money roundMoney(double minor) {
+    if (!(std::fabs(minor) < 0x1p63)) throw std::logic_error("Amount is out of range\n");
+    return std::llround(minor);
+}
+
+enum class PaymentType : uint8_t { Annuity, Differentiated };
+
+/// @brief  Loans as struct of arrays. Terms are in months.
+struct LoanPortfolio {
+    std::vector<money> principal;
+    std::vector<rate> annual_rate;
+    std::vector<uint32_t> term;
+    std::vector<PaymentType> type;
+
+    std::size_t size() const noexcept { return principal.size(); }
+
+    void add(money loan_principal, rate loan_rate, uint32_t months, PaymentType payment_type) {
+        principal.push_back(loan_principal);
+        annual_rate.push_back(loan_rate);
+        term.push_back(months);
+        type.push_back(payment_type);
+    }
+
+    /// @brief  Rates are millionths, convert fractions with toRate() instead of truncating them.
+    /// Only floating point rates are deleted, plain integer arguments still pick add() above.
+    template <typename T, std::enable_if_t<std::is_floating_point_v<T>, int> = 0>
+    void add(money, T, uint32_t, PaymentType) = delete;
+};
+
+struct LoanRow {
+    uint32_t loan;
+    uint32_t period;
+    money payment;
+    money principal;
+    money interest;
+    money balance;
+};
+
+struct LoanTotals {
+    std::vector<money> first_payment;
+    std::vector<money> last_payment;
+    std::vector<money> total_payment;
+    std::vector<money> overpayment;
+};
+
+/// @brief  Deposits as struct of arrays. Interest is capitalized every `capitalization` months
+/// or paid out monthly if it is 0. Replenishments (positive) and withdrawals (negative) of the
+/// i-th deposit are the operations [operations_offset[i], operations_offset[i + 1]), applied at
+/// the beginning of their month.
+struct DepositPortfolio {
+    std::vector<money> amount;
+    std::vector<rate> annual_rate;
+    std::vector<uint32_t> term;
+    std::vector<uint32_t> capitalization;
+    std::vector<std::size_t> operations_offset{0};
+    std::vector<uint32_t> operation_month;
+    std::vector<money> operation_amount;
+
+    std::size_t size() const noexcept { return amount.size(); }
+
+    void add(money deposit_amount, rate deposit_rate, uint32_t months,
+             uint32_t capitalization_period,
+             const std::vector<std::pair<uint32_t, money>>& operations = {}) {
+        amount.push_back(deposit_amount);
+        annual_rate.push_back(deposit_rate);
+        term.push_back(months);
+        capitalization.push_back(capitalization_period);
+
+        std::vector<std::pair<uint32_t, money>> sorted = operations;
+        std::stable_sort(sorted.begin(), sorted.end(),
+                         [](const auto& a, const auto& b) { return a.first < b.first; });
+        for (const auto& [month, operation] : sorted) {
+            operation_month.push_back(month);
+            operation_amount.push_back(operation);
+        }
+        operations_offset.push_back(operation_month.size());
+    }
+
+    /// @brief  Rates are millionths, convert fractions with toRate() instead of truncating them.
+    template <typename T, std::enable_if_t<std::is_floating_point_v<T>, int> = 0>
+    void add(money, T, uint32_t, uint32_t,
+             const std::vector<std::pair<uint32_t, money>>& = {}) = delete;
+};
+
+struct DepositRow {
+    uint32_t deposit;
+    uint32_t period;
+    money operation;
+    money interest;
+    money payout;
+    money balance;
+};
+
+struct DepositTotals {
+    std::vector<money> accrued_interest;
+    std::vector<money> paid_out;
+    std::vector<money> final_balance;
+};
+
+/// @brief  Monthly annuity payments of at most `annuity_block` loans [begin, end) by the closed
+/// formula P * r * g / (g - 1), g = (1 + r)^n. As the term is an integer, g is computed by square
+/// and multiply over the bits of the longest term of the block, every lane selecting 1 for its
+/// zero bits with a blend, so all the loops are free of calls and branches. GCC vectorizes them
+/// at -O3 (or -O2 -ftree-vectorize); the integer to double conversions need AVX-512DQ.
+inline constexpr std::size_t annuity_block = 256;
+
+inline void annuityPayments(const LoanPortfolio& loans, std::size_t begin, std::size_t end,
+                            double* payments) {
+    const money* principal = loans.principal.data() + begin;
+    const rate* annual = loans.annual_rate.data() + begin;
+    const uint32_t* term = loans.term.data() + begin;
+    std::size_t size = std::min(end - begin, annuity_block);
+
+    double monthly[annuity_block];
+    double amount[annuity_block];
+    double base[annuity_block];
+    double growth[annuity_block];
+    uint32_t longest = 0;
+
+    for (std::size_t i = 0; i < size; i++) {
+        monthly[i] = static_cast<double>(annual[i]) * (1.0 / (12 * rate_scale));
+        amount[i] = static_cast<double>(principal[i]);
+    }
+    for (std::size_t i = 0; i < size; i++) {
+        base[i] = 1 + monthly[i];
+        growth[i] = 1;
+        longest |= term[i];
+    }
+
+    for (uint32_t shift = 0; (longest >> shift) != 0; shift++) {
+        for (std::size_t i = 0; i < size; i++) {
+            // A select and not bit * base + (1 - bit): base keeps squaring past the short terms
+            // up to the longest one, so it may be infinite, and 0 * inf would give NaN.
+            double factor = ((term[i] >> shift) & 1) ? base[i] : 1.0;
+            growth[i] *= factor;
+            base[i] *= base[i];
+        }
+    }
+
+    for (std::size_t i = 0; i < size; i++) {
+        // Without interest g is 1: the denominator is replaced by 1 and the annuity part is 0.
+        double months = term[i];
+        double linear = static_cast<double>(monthly[i] == 0);
+        double annuity = amount[i] * monthly[i] * growth[i] / (growth[i] - 1 + linear);
+        payments[i] = annuity + linear * amount[i] / months;
+    }
+}
+
+/// @brief  Computes the payment schedules of loan and deposit portfolios in parallel. Rows are
+/// streamed to the sink in chunks of a per worker buffer instead of being stored:
+///     sink(std::size_t worker, const Row* rows, std::size_t quantity)
+/// The sink is called concurrently with different worker indices.
+class ScheduleEngine {
+private:
+    std::size_t threads_;
+    std::size_t buffer_rows_;
+
+    /// @brief  Runs `process(worker, begin, end)` on the contiguous parts of [0, size).
+    template <typename Process>
+    void parallel(std::size_t size, Process process) const {
+        std::size_t workers = std::max<std::size_t>(1, std::min(threads_, size));
+        std::size_t part = (size + workers - 1) / std::max<std::size_t>(1, workers);
+        std::vector<std::exception_ptr> errors(workers);
+        std::vector<std::thread> pool;
+
+        auto run = [&](std::size_t worker) {
+            try {
+                std::size_t begin = std::min(size, worker * part);
+                process(worker, begin, std::min(size, begin + part));
+            } catch (...) {
+                errors[worker] = std::current_exception();
+            }
+        };
+
+        for (std::size_t worker = 1; worker < workers; worker++) pool.emplace_back(run, worker);
+        run(0);
+        for (std::thread& thread : pool) thread.join();
+
+        for (const std::exception_ptr& error : errors)
+            if (error) std::rethrow_exception(error);
+    }
+
+    template <typename Row, typename Sink>
+    class RowStream {
+        Sink& sink_;
+        std::size_t worker_;
+        std::size_t capacity_;
+        std::vector<Row> rows_;
+
+    public:
+        RowStream(Sink& sink, std::size_t worker, std::size_t capacity)
+            : sink_(sink), worker_(worker), capacity_(capacity) {
+            rows_.reserve(capacity);
+        }
+
+        void push(const Row& row) {
+            rows_.push_back(row);
+            if (rows_.size() == capacity_) flush();
+        }
+
+        void flush() {
+            if (!rows_.empty()) sink_(worker_, rows_.data(), rows_.size());
+            rows_.clear();
+        }
+    };
+
+    static void validate(const LoanPortfolio& loans) {
+        std::size_t size = loans.size();
+        if (loans.annual_rate.size() != size || loans.term.size() != size ||
+            loans.type.size() != size) {
+            throw std::logic_error("Inconsistent loan portfolio\n");
+        }
+        for (std::size_t i = 0; i < size; i++) {
+            if (loans.term[i] == 0 || loans.term[i] > max_term || loans.principal[i] < 0 ||
+                loans.principal[i] > max_principal || loans.annual_rate[i] < 0 ||
+                loans.annual_rate[i] > max_rate)
+                throw std::logic_error("Invalid loan parameters\n");
+        }
+    }
+
+    static void validate(const DepositPortfolio& deposits) {
+        std::size_t size = deposits.size();
+        if (deposits.annual_rate.size() != size || deposits.term.size() != size ||
+            deposits.capitalization.size() != size ||
+            deposits.operations_offset.size() != size + 1 ||
+            deposits.operation_amount.size() != deposits.operation_month.size() ||
+            deposits.operations_offset.back() != deposits.operation_month.size()) {
+            throw std::logic_error("Inconsistent deposit portfolio\n");
+        }
+        for (std::size_t i = 0; i < size; i++) {
+            if (deposits.term[i] == 0 || deposits.amount[i] < 0 ||
+                deposits.annual_rate[i] < 0)
+                throw std::logic_error("Invalid deposit parameters\n");
+        }
+    }
+
+public:
+    ScheduleEngine(std::size_t threads = std::thread::hardware_concurrency(),
+                   std::size_t buffer_rows = 4096)
+        : threads_(std::max<std::size_t>(1, threads)),
+          buffer_rows_(std::max<std::size_t>(1, buffer_rows)) {}
+
+    /// @brief  Streams the monthly schedule rows of every loan. Interest of a period is
+    /// monthlyInterest() of the balance, the last payment closes the remaining balance.
+    template <typename Sink>
+    LoanTotals loans(const LoanPortfolio& portfolio, Sink& sink) const {
+        validate(portfolio);
+        std::size_t size = portfolio.size();
+        LoanTotals totals{std::vector<money>(size), std::vector<money>(size),
+                          std::vector<money>(size), std::vector<money>(size)};
+
+        parallel(size, [&](std::size_t worker, std::size_t begin, std::size_t end) {
+            RowStream<LoanRow, Sink> stream(sink, worker, buffer_rows_);
+            double annuity[annuity_block];
+
+            for (std::size_t block = begin; block < end; block += annuity_block) {
+                std::size_t block_end = std::min(end, block + annuity_block);
+                annuityPayments(portfolio, block, block_end, annuity);
+
+                for (std::size_t i = block; i < block_end; i++) {
+                    rate annual = portfolio.annual_rate[i];
+                    uint32_t term = portfolio.term[i];
+                    bool is_annuity = portfolio.type[i] == PaymentType::Annuity;
+                    money balance = portfolio.principal[i];
+                    money payment = roundMoney(annuity[i - block]);
+                    money principal_part = portfolio.principal[i] / term;
+                    money total = 0;
+
+                    for (uint32_t period = 1; period <= term; period++) {
+                        money interest = monthlyInterest(balance, annual);
+                        money repaid = (is_annuity) ? payment - interest : principal_part;
+                        if (period == term || repaid > balance) repaid = balance;
+
+                        balance -= repaid;
+                        total += repaid + interest;
+                        stream.push(LoanRow{static_cast<uint32_t>(i), period, repaid + interest,
+                                            repaid, interest, balance});
+
+                        if (period == 1) totals.first_payment[i] = repaid + interest;
+                        if (period == term) totals.last_payment[i] = repaid + interest;
+                    }
+
+                    totals.total_payment[i] = total;
+                    totals.overpayment[i] = total - portfolio.principal[i];
+                }
+            }
+            stream.flush();
+        });
+
+        return totals;
+    }
+
+    /// @brief  Streams the monthly rows of every deposit. Interest of a month is
+    /// monthlyInterest() of the balance; it is added to the balance at the capitalization months
+    /// or paid out. A withdrawal larger than the balance is limited by it.
+    template <typename Sink>
+    DepositTotals deposits(const DepositPortfolio& portfolio, Sink& sink) const {
+        validate(portfolio);
+        std::size_t size = portfolio.size();
+        DepositTotals totals{std::vector<money>(size), std::vector<money>(size),
+                             std::vector<money>(size)};
+
+        parallel(size, [&](std::size_t worker, std::size_t begin, std::size_t end) {
+            RowStream<DepositRow, Sink> stream(sink, worker, buffer_rows_);
+
+            for (std::size_t i = begin; i < end; i++) {
+                rate annual = portfolio.annual_rate[i];
+                uint32_t capitalization = portfolio.capitalization[i];
+                std::size_t operation = portfolio.operations_offset[i];
+                std::size_t operations_end = portfolio.operations_offset[i + 1];
+                money balance = portfolio.amount[i];
+                money accrued = 0;
+                money pending = 0;
+                money paid_out = 0;
+
+                for (uint32_t period = 1; period <= portfolio.term[i]; period++) {
+                    money applied = 0;
+                    for (; operation < operations_end &&
+                           portfolio.operation_month[operation] <= period;
+                         operation++) {
+                        money requested = portfolio.operation_amount[operation];
+                        applied += std::max(-balance - applied, requested);
+                    }
+                    balance += applied;
+
+                    money interest = monthlyInterest(balance, annual);
+                    money payout = 0;
+                    accrued += interest;
+                    pending += interest;
+
+                    if (capitalization == 0) {
+                        payout = pending;
+                        pending = 0;
+                    } else if (period % capitalization == 0 || period == portfolio.term[i]) {
+                        balance += pending;
+                        pending = 0;
+                    }
+                    paid_out += payout;
+
+                    stream.push(DepositRow{static_cast<uint32_t>(i), period, applied, interest,
+                                           payout, balance});
+                }
+
+                totals.accrued_interest[i] = accrued;
+                totals.paid_out[i] = paid_out;
+                totals.final_balance[i] = balance;
+            }
+            stream.flush();
+        });
+
+        return totals;
+    }
+};
+}  // namespace finance
+}  // namespace calculations
+
+#endif  // __FINANCE_HPP__
@@ -0,0 +1,119 @@
+#include <cmath>
+#include <iostream>
+#include <string>
+
+#include <vector>
+
+#include "finance.hpp"
+
+namespace {
+using namespace calculations::finance;
+
+std::size_t failures = 0;
+
+void check(bool condition, const std::string& description) {
+    if (!condition) {
+        std::cerr << "FAILED: " << description << std::endl;
+        failures++;
+    }
+}
+
+template <typename Call>
+bool throws(Call call) {
+    try {
+        call();
+    } catch (const std::exception&) {
+        return true;
+    }
+    return false;
+}
+
+void checkRounding() {
+    check(monthlyInterest(40, toRate(0.15)) == 1, "15% on 0.40 is 1 cent a month");
+    check(monthlyInterest(toMoney("1100.00"), toRate("0.0126")) == 116,
+          "1.26% on 1100.00 is 1.16 a month");
+    check(monthlyInterest(-40, toRate(0.15)) == -1, "interest rounds half away from zero");
+    check(toMoney(1.005) == 101, "toMoney(1.005) is 101 cents");
+    check(toMoney("1.005") == 101, "toMoney(\"1.005\") is 101 cents");
+    check(toMoney(-2.675) == -268, "toMoney(-2.675) is -268 cents");
+    check(toMoney(12345678901234.56) == 1234567890123456, "toMoney keeps cents of 10^13");
+    check(toRate(0.0126) == 12600 && toRate("1.26e-2") == 12600, "1.26% is 12600 millionths");
+    check(throws([] { toMoney(1e20); }), "toMoney(1e20) is out of range");
+    check(throws([] { toMoney(std::nan("")); }), "toMoney(NaN) is rejected");
+    check(throws([] { roundMoney(std::nan("")); }), "roundMoney(NaN) is rejected");
+}
+
+void checkLoans() {
+    LoanPortfolio portfolio;
+    portfolio.add(100000, 120000, 12, PaymentType::Annuity);
+    portfolio.add(100000, 120000, 12, PaymentType::Differentiated);
+    portfolio.add(120000, 0, 12, PaymentType::Annuity);
+
+    ScheduleEngine engine(2, 5);
+    std::vector<money> paid(portfolio.size());
+    std::size_t rows = 0;
+    auto sink = [&](std::size_t, const LoanRow* row, std::size_t quantity) {
+        for (std::size_t i = 0; i < quantity; i++) paid[row[i].loan] += row[i].payment;
+        rows += quantity;
+    };
+    LoanTotals totals = engine.loans(portfolio, sink);
+
+    check(totals.first_payment[0] == 8885 && totals.last_payment[0] == 8884 &&
+              totals.total_payment[0] == 106619,
+          "annuity of 1000.00 at 12% for 12 months");
+    check(totals.first_payment[1] == 9333 && totals.last_payment[1] == 8420 &&
+              totals.total_payment[1] == 106500,
+          "differentiated loan of 1000.00 at 12% for 12 months");
+    check(totals.first_payment[2] == 10000 && totals.overpayment[2] == 0,
+          "annuity without interest");
+    check(rows == 36 && paid[0] == totals.total_payment[0] && paid[1] == totals.total_payment[1],
+          "streamed rows add up to the totals");
+}
+
+void checkOverflowingAnnuity() {
+    LoanPortfolio portfolio;
+    for (int i = 0; i < 10; i++) portfolio.add(100000, 120000, 12, PaymentType::Annuity);
+    portfolio.add(100000, 360000, 65536, PaymentType::Annuity);
+
+    double payments[annuity_block];
+    annuityPayments(portfolio, 0, portfolio.size(), payments);
+    bool finite = true;
+    for (int i = 0; i < 10; i++) finite &= std::fabs(payments[i] - 8884.88) < 0.01;
+    check(finite, "a long loan does not turn the payments of its block into NaN");
+
+    ScheduleEngine engine(1);
+    auto sink = [](std::size_t, const LoanRow*, std::size_t) {};
+    check(throws([&] { engine.loans(portfolio, sink); }), "a term of 65536 months is rejected");
+
+    LoanPortfolio largest;
+    largest.add(max_principal, max_rate, max_term, PaymentType::Annuity);
+    LoanTotals totals = engine.loans(largest, sink);
+    check(totals.total_payment[0] > max_principal && totals.overpayment[0] > 0,
+          "the largest allowed loan fits money");
+}
+
+void checkDeposits() {
+    DepositPortfolio portfolio;
+    portfolio.add(100000, 120000, 12, 1);
+    portfolio.add(100000, 120000, 12, 0, {{2, -200000}});
+
+    ScheduleEngine engine(2);
+    auto sink = [](std::size_t, const DepositRow*, std::size_t) {};
+    DepositTotals totals = engine.deposits(portfolio, sink);
+
+    check(totals.accrued_interest[0] == 12684 && totals.final_balance[0] == 112684,
+          "deposit of 1000.00 at 12% capitalized monthly");
+    check(totals.paid_out[1] == 1000 && totals.final_balance[1] == 0,
+          "withdrawal is limited by the balance");
+}
+}  // namespace
+
+int main() {
+    checkRounding();
+    checkLoans();
+    checkOverflowingAnnuity();
+    checkDeposits();
+
+    if (failures == 0) std::cout << "All checks passed" << std::endl;
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,468 @@
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <unordered_map>
+#include <vector>
+
+#include "calculations.hpp"
+#include "processor.hpp"
+
+#ifndef __INCREMENTAL_HPP__
+#define __INCREMENTAL_HPP__
+
+namespace incremental {
+/// @brief  Lexeme of the edited formula together with its span in the source text.
+struct Lexeme {
+    enum class Kind : uint8_t { Number, Variable, Symbol, Unknown };
+
+    Kind kind;
+    char symbol;
+    double value;
+    std::size_t begin;
+    std::size_t length;
+
+    std::size_t end() const noexcept { return begin + length; }
+};
+
+/// @brief  Lexer which keeps the previous lexemes and re-lexes only the edited span.
+/// Unknown words do not throw here: while typing "sin" the formula goes through "s" and "si",
+/// so they are kept as Unknown lexemes and reported by the parser instead.
+class IncrementalLexer {
+    using lexemes_storage = std::vector<Lexeme>;
+
+private:
+    std::string source_;
+    lexemes_storage lexemes_;
+    std::size_t relexed_ = 0;
+
+    std::size_t skipSpaces(std::size_t current) const noexcept {
+        while (current < source_.size() && source_[current] == ' ') current++;
+        return current;
+    }
+
+    /// @brief  Value of the number lexeme, throws with its position if it does not fit a double.
+    double number(std::size_t begin, std::size_t length) const {
+        try {
+            return std::stod(source_.substr(begin, length));
+        } catch (const std::out_of_range&) {
+            throw std::out_of_range("Number at position " + std::to_string(begin) +
+                                    " is out of range\n");
+        }
+    }
+
+    Lexeme lexemeAt(std::size_t current) const {
+        char symbol = source_[current];
+
+        if (symbol == 'x') return Lexeme{Lexeme::Kind::Variable, symbol, 0, current, 1};
+
+        if (std::isdigit(static_cast<unsigned char>(symbol))) {
+            // The second '.' ends the number, so "1.2.3" is "1.2" and the parser rejects ".3".
+            std::size_t counter = current;
+            bool fraction = false;
+            for (; counter < source_.size(); counter++) {
+                if (source_[counter] == '.' && !fraction) {
+                    fraction = true;
+                } else if (!std::isdigit(static_cast<unsigned char>(source_[counter]))) {
+                    break;
+                }
+            }
+            return Lexeme{Lexeme::Kind::Number, 0, number(current, counter - current), current,
+                          counter - current};
+        }
+
+        if (preprocess::available_operators.count(symbol) || symbol == '(' || symbol == ')')
+            return Lexeme{Lexeme::Kind::Symbol, symbol, 0, current, 1};
+
+        if (std::isalpha(static_cast<unsigned char>(symbol))) {
+            for (std::size_t j = 1; j <= 4 && current + j <= source_.size(); j++) {
+                auto function = preprocess::available_functions.find(source_.substr(current, j));
+                if (function != preprocess::available_functions.end())
+                    return Lexeme{Lexeme::Kind::Symbol, function->second, 0, current, j};
+            }
+        }
+
+        return Lexeme{Lexeme::Kind::Unknown, symbol, 0, current, 1};
+    }
+
+    /// @brief  Lexes from `current` up to the end of the source or until the lexer reaches the
+    /// start of an old lexeme which lies behind the edited span.
+    void relex(std::size_t current, std::size_t edit_end, const lexemes_storage& tail,
+               std::ptrdiff_t delta) {
+        std::size_t synchronized = 0;
+
+        for (current = skipSpaces(current); current < source_.size();
+             current = skipSpaces(current)) {
+            while (synchronized < tail.size() && tail[synchronized].begin + delta < current)
+                synchronized++;
+
+            if (current >= edit_end && synchronized < tail.size() &&
+                tail[synchronized].begin + delta == current) {
+                break;
+            }
+
+            lexemes_.push_back(lexemeAt(current));
+            current = lexemes_.back().end();
+            relexed_++;
+        }
+
+        for (; current < source_.size() && synchronized < tail.size(); synchronized++) {
+            Lexeme shifted = tail[synchronized];
+            shifted.begin += delta;
+            lexemes_.push_back(shifted);
+        }
+    }
+
+public:
+    IncrementalLexer() = default;
+
+    const lexemes_storage& reset(const std::string& source) {
+        source_ = source;
+        lexemes_.clear();
+        relexed_ = 0;
+        try {
+            relex(0, 0, {}, 0);
+        } catch (const std::exception&) {
+            source_.clear();
+            lexemes_.clear();
+            throw;
+        }
+
+        return lexemes_;
+    }
+
+    /// @brief  Replaces `erased` characters at `position` with `inserted` and re-lexes only the
+    /// lexemes whose text could have been changed by this edit.
+    const lexemes_storage& edit(std::size_t position, std::size_t erased,
+                                const std::string& inserted) {
+        if (position > source_.size() || erased > source_.size() - position) {
+            throw std::out_of_range("Edit is out of the formula bounds\n");
+        }
+
+        // A lexeme touching the edit may grow into it (digits, function names), and unknown
+        // letters before it may turn into a function, so restart before all of them.
+        std::size_t first = 0;
+        while (first < lexemes_.size() && lexemes_[first].end() < position) first++;
+        while (first > 0 && (lexemes_[first - 1].kind == Lexeme::Kind::Unknown ||
+                             lexemes_[first - 1].kind == Lexeme::Kind::Variable))
+            first--;
+
+        std::size_t restart = (first < lexemes_.size()) ? std::min(lexemes_[first].begin, position)
+                              : (first > 0)             ? lexemes_[first - 1].end()
+                                                        : 0;
+
+        std::size_t tail_begin = first;
+        while (tail_begin < lexemes_.size() && lexemes_[tail_begin].begin < position + erased)
+            tail_begin++;
+        lexemes_storage replaced(lexemes_.begin() + first, lexemes_.begin() + tail_begin);
+        lexemes_storage tail(lexemes_.begin() + tail_begin, lexemes_.end());
+        lexemes_.erase(lexemes_.begin() + first, lexemes_.end());
+
+        std::string erased_text = source_.substr(position, erased);
+        source_.replace(position, erased, inserted);
+        relexed_ = 0;
+        try {
+            relex(restart, position + inserted.size(), tail,
+                  static_cast<std::ptrdiff_t>(inserted.size()) -
+                      static_cast<std::ptrdiff_t>(erased));
+        } catch (const std::exception&) {
+            // Leave the previous version, so the next edit positions still refer to it.
+            source_.replace(position, inserted.size(), erased_text);
+            lexemes_.resize(first);
+            lexemes_.insert(lexemes_.end(), replaced.begin(), replaced.end());
+            lexemes_.insert(lexemes_.end(), tail.begin(), tail.end());
+            throw;
+        }
+
+        return lexemes_;
+    }
+
+    const std::string& source() const noexcept { return source_; }
+    const lexemes_storage& lexemes() const noexcept { return lexemes_; }
+
+    /// @brief  Quantity of lexemes produced by the last reset or edit.
+    std::size_t relexed() const noexcept { return relexed_; }
+};
+
+/// @brief  Version of the edited formula which an evaluation belongs to. Evaluation stops as soon
+/// as a newer version has been published.
+struct EvaluationTicket {
+    const std::atomic<uint64_t>& latest;
+    uint64_t version;
+
+    bool stale() const noexcept { return latest.load(std::memory_order_relaxed) != version; }
+};
+
+/// @brief  Expression tree of the formula with structurally equal subtrees shared between
+/// versions. Every node caches its values on the current grid, so after an edit only the nodes
+/// created by this edit are evaluated again.
+/// Building and evaluation must not run concurrently: cancel the stale evaluation and wait for it
+/// before building a new version.
+class ExpressionGraph {
+    static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+    static constexpr std::size_t cancellation_step = 4096;
+
+    struct NodeKey {
+        Lexeme::Kind kind;
+        char symbol;
+        double value;
+        std::size_t left;
+        std::size_t right;
+
+        bool operator==(const NodeKey& compare) const {
+            return kind == compare.kind && symbol == compare.symbol &&
+                   std::memcmp(&value, &compare.value, sizeof(double)) == 0 &&
+                   left == compare.left && right == compare.right;
+        }
+    };
+
+    struct NodeKeyHash {
+        std::size_t operator()(const NodeKey& key) const noexcept {
+            uint64_t bits;
+            std::memcpy(&bits, &key.value, sizeof(double));
+            std::size_t seed = std::hash<uint64_t>()(bits);
+            for (std::size_t part : {static_cast<std::size_t>(key.kind),
+                                     static_cast<std::size_t>(key.symbol), key.left, key.right})
+                seed ^= part + 0x9e3779b97f4a7c15 + (seed << 6) + (seed >> 2);
+            return seed;
+        }
+    };
+
+    struct Node {
+        NodeKey key;
+        uint64_t generation = 0;
+        bool alive = false;
+        bool evaluated = false;
+        std::vector<double> samples;
+    };
+
+private:
+    calculations::ClassicAlgebra algebra_;
+    std::vector<Node> nodes_;
+    std::vector<std::size_t> free_nodes_;
+    std::unordered_map<NodeKey, std::size_t, NodeKeyHash> interned_;
+    std::vector<double> grid_;
+    std::size_t root_ = npos;
+    uint64_t generation_ = 0;
+    std::size_t created_ = 0;
+
+    std::size_t intern(const NodeKey& key) {
+        auto found = interned_.find(key);
+        if (found != interned_.end()) return found->second;
+
+        std::size_t index = nodes_.size();
+        if (!free_nodes_.empty()) {
+            index = free_nodes_.back();
+            free_nodes_.pop_back();
+        } else {
+            nodes_.emplace_back();
+        }
+
+        nodes_[index].key = key;
+        nodes_[index].alive = true;
+        nodes_[index].evaluated = false;
+        interned_.emplace(key, index);
+        created_++;
+
+        return index;
+    }
+
+    void applyOperator(char symbol, std::vector<std::size_t>& operands) {
+        bool is_binary_operator = preprocess::available_operators.count(symbol) != 0;
+        std::size_t arity = (is_binary_operator) ? 2 : 1;
+
+        if (operands.size() < arity) throw std::logic_error("Invalid expression\n");
+
+        std::size_t right = (is_binary_operator) ? operands.back() : npos;
+        if (is_binary_operator) operands.pop_back();
+        std::size_t left = operands.back();
+        operands.pop_back();
+
+        operands.push_back(intern(NodeKey{Lexeme::Kind::Symbol, symbol, 0, left, right}));
+    }
+
+    int8_t priority(char symbol) const {
+        return preprocess::operators_priorities.find(symbol)->second;
+    }
+
+    void collectGarbage() {
+        std::vector<std::size_t> pending{root_};
+        while (!pending.empty()) {
+            std::size_t index = pending.back();
+            pending.pop_back();
+            if (index == npos || nodes_[index].generation == generation_) continue;
+
+            nodes_[index].generation = generation_;
+            pending.push_back(nodes_[index].key.left);
+            pending.push_back(nodes_[index].key.right);
+        }
+
+        for (std::size_t index = 0; index < nodes_.size(); index++) {
+            if (nodes_[index].alive && nodes_[index].generation != generation_) {
+                interned_.erase(nodes_[index].key);
+                nodes_[index].alive = false;
+                nodes_[index].samples.clear();
+                free_nodes_.push_back(index);
+            }
+        }
+    }
+
+    bool evaluateNode(Node& node, const EvaluationTicket& ticket) {
+        node.samples.resize(grid_.size());
+        const NodeKey& key = node.key;
+
+        for (std::size_t begin = 0; begin < grid_.size(); begin += cancellation_step) {
+            if (ticket.stale()) return false;
+            std::size_t end = std::min(grid_.size(), begin + cancellation_step);
+
+            if (key.kind == Lexeme::Kind::Number) {
+                std::fill(node.samples.begin() + begin, node.samples.begin() + end, key.value);
+            } else if (key.kind == Lexeme::Kind::Variable) {
+                std::copy(grid_.begin() + begin, grid_.begin() + end, node.samples.begin() + begin);
+            } else {
+                auto rule = algebra_.getRule(key.symbol);
+                const std::vector<double>& left = nodes_[key.left].samples;
+
+                if (key.right == npos) {
+                    for (std::size_t i = begin; i < end; i++) node.samples[i] = rule(left[i]);
+                } else {
+                    const std::vector<double>& right = nodes_[key.right].samples;
+                    for (std::size_t i = begin; i < end; i++)
+                        node.samples[i] = rule(left[i], right[i]);
+                }
+            }
+        }
+
+        return true;
+    }
+
+public:
+    ExpressionGraph() { algebra_.initializeRulesInterface(); }
+    ExpressionGraph(const ExpressionGraph&) = delete;
+    ExpressionGraph(ExpressionGraph&&) = delete;
+
+    /// @brief  Builds the tree with the same priorities as DjkstraProcessor, reusing the nodes of
+    /// the previous versions. Returns the quantity of the newly created nodes.
+    std::size_t build(const std::vector<Lexeme>& lexemes) {
+        std::vector<std::size_t> operands;
+        std::vector<char> operators;
+        bool operand_expected = true;
+        created_ = 0;
+        generation_++;
+        root_ = npos;
+
+        for (const Lexeme& lexeme : lexemes) {
+            if (lexeme.kind == Lexeme::Kind::Unknown) {
+                throw preprocess::exceptions::InvalidFunctionException(
+                    "Invalid function or operator\n");
+            }
+
+            // Operands, functions and '(' start an operand, binary operators and ')' follow one,
+            // so "3cos", "x sin" and "2 3 +" are rejected instead of being applied at the end.
+            bool is_symbol = lexeme.kind == Lexeme::Kind::Symbol && lexeme.symbol != 'e';
+            bool starts_operand = !is_symbol || lexeme.symbol == '(' ||
+                                  (lexeme.symbol != ')' &&
+                                   preprocess::available_operators.count(lexeme.symbol) == 0);
+            if (starts_operand != operand_expected) {
+                throw preprocess::exceptions::InvalidFunctionException(
+                    (starts_operand) ? "Missing operator between operands\n"
+                                     : "Function or operator has no operand\n");
+            }
+            operand_expected = is_symbol && lexeme.symbol != ')';
+
+            if (lexeme.kind != Lexeme::Kind::Symbol) {
+                operands.push_back(intern(NodeKey{lexeme.kind, 0, lexeme.value, npos, npos}));
+            } else if (lexeme.symbol == 'e') {
+                operands.push_back(
+                    intern(NodeKey{Lexeme::Kind::Number, 0, std::exp(1), npos, npos}));
+            } else if (lexeme.symbol == '(') {
+                operators.push_back(lexeme.symbol);
+            } else if (lexeme.symbol == ')') {
+                while (!operators.empty() && operators.back() != '(') {
+                    applyOperator(operators.back(), operands);
+                    operators.pop_back();
+                }
+                if (operators.empty())
+                    throw preprocess::exceptions::BracketSequenceException(
+                        "Invalid bracket sequence");
+                operators.pop_back();
+            } else {
+                // Functions are prefix ones, so they never take the left operand off the stack.
+                bool is_function = preprocess::available_operators.count(lexeme.symbol) == 0;
+                while (!is_function && !operators.empty() &&
+                       priority(operators.back()) - priority(lexeme.symbol) >= 0) {
+                    applyOperator(operators.back(), operands);
+                    operators.pop_back();
+                }
+                operators.push_back(lexeme.symbol);
+            }
+        }
+
+        if (operand_expected && !lexemes.empty()) {
+            throw preprocess::exceptions::InvalidFunctionException(
+                "Function or operator has no operand\n");
+        }
+
+        for (; !operators.empty(); operators.pop_back()) {
+            if (operators.back() == '(')
+                throw preprocess::exceptions::BracketSequenceException("Invalid bracket sequence");
+            applyOperator(operators.back(), operands);
+        }
+
+        if (operands.size() != 1) throw std::logic_error("Invalid expression\n");
+
+        root_ = operands.back();
+        collectGarbage();
+
+        return created_;
+    }
+
+    /// @brief  Sets the abscissas of the plot, dropping the cached values if the grid differs.
+    void setGrid(const std::vector<double>& grid) {
+        if (grid == grid_) return;
+
+        grid_ = grid;
+        for (Node& node : nodes_) node.evaluated = false;
+    }
+
+    /// @brief  Evaluates the nodes which have no cached values on the current grid. Returns false
+    /// if the ticket became stale before the root was evaluated.
+    bool evaluate(const EvaluationTicket& ticket) {
+        if (root_ == npos) return false;
+
+        std::vector<std::pair<std::size_t, bool>> pending{{root_, false}};
+        while (!pending.empty()) {
+            auto [index, children_ready] = pending.back();
+            pending.pop_back();
+            if (index == npos || nodes_[index].evaluated) continue;
+
+            if (children_ready) {
+                if (!evaluateNode(nodes_[index], ticket)) return false;
+                nodes_[index].evaluated = true;
+            } else {
+                pending.push_back({index, true});
+                pending.push_back({nodes_[index].key.left, false});
+                pending.push_back({nodes_[index].key.right, false});
+            }
+        }
+
+        return true;
+    }
+
+    bool ready() const noexcept { return root_ != npos && nodes_[root_].evaluated; }
+
+    const std::vector<double>& grid() const noexcept { return grid_; }
+
+    /// @brief  Values of the formula on the grid, valid when ready() is true.
+    const std::vector<double>& samples() const {
+        if (!ready()) throw std::logic_error("Formula is not evaluated\n");
+        return nodes_[root_].samples;
+    }
+};
+}  // namespace incremental
+
+#endif  // __INCREMENTAL_HPP__
@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <unordered_map>
+#include <vector>
+
+#include <poll.h>
+
+#include "server.hpp"
+
+namespace {
+using clock_type = std::chrono::steady_clock;
+
+struct ClientOptions {
+    std::string socket_path;
+    std::size_t connections = 16;
+    std::size_t requests = 1000;
+    std::size_t points = 256;
+    std::size_t depth = 4;
+    std::vector<std::string> formulas = {"sin(x)*x", "x^2+3*x-1", "sqrt(x)/(1+x)"};
+};
+
+struct ClientReport {
+    /// @brief  Latencies of the successful responses only.
+    std::vector<double> latencies;
+    /// @brief  Status::Error responses.
+    std::size_t errors = 0;
+    /// @brief  Requests left without a response when the connection broke.
+    std::size_t lost = 0;
+};
+
+/// @brief  Keeps `depth` requests of one connection in flight and measures their latencies.
+/// Sending never blocks while responses wait: a server whose output to us is full stops reading
+/// the requests, so the client has to keep reading as long as it has something to send.
+ClientReport runClient(const ClientOptions& options, std::size_t client) {
+    ClientReport report;
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_un address = service::protocol::socketAddress(options.socket_path);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        if (fd >= 0) close(fd);
+        throw service::exceptions::SystemException("connect");
+    }
+
+    std::vector<double> x(options.points);
+    for (std::size_t i = 0; i < x.size(); i++) x[i] = 0.01 * (i + client);
+
+    std::unordered_map<uint64_t, clock_type::time_point> started;
+    std::size_t sent = 0;
+    std::size_t received = 0;
+    std::string output;
+    std::size_t output_offset = 0;
+    std::string input;
+    std::size_t input_offset = 0;
+    char chunk[64 << 10];
+
+    while (received < options.requests) {
+        for (; sent < options.requests && sent - received < options.depth; sent++) {
+            service::protocol::Request request{
+                sent, options.formulas[(client + sent) % options.formulas.size()], x};
+            service::protocol::appendRequest(output, request);
+            started.emplace(sent, clock_type::now());
+        }
+
+        bool sending = output_offset < output.size();
+        pollfd descriptor{fd, static_cast<short>(POLLIN | ((sending) ? POLLOUT : 0)), 0};
+        if (poll(&descriptor, 1, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        if (sending && (descriptor.revents & POLLOUT)) {
+            ssize_t size = send(fd, output.data() + output_offset, output.size() - output_offset,
+                                MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (size < 0 && errno != EAGAIN && errno != EWOULDBLOCK) break;
+            if (size > 0) output_offset += size;
+            if (output_offset == output.size()) {
+                output.clear();
+                output_offset = 0;
+            }
+        }
+
+        if (!(descriptor.revents & (POLLIN | POLLHUP | POLLERR))) continue;
+        ssize_t size = recv(fd, chunk, sizeof(chunk), MSG_DONTWAIT);
+        if (size == 0 || (size < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) break;
+        if (size > 0) input.append(chunk, size);
+
+        while (auto payload = service::protocol::nextFrame(input, input_offset)) {
+            service::protocol::Response response = service::protocol::parseResponse(*payload);
+            auto start = started.find(response.id);
+            if (start == started.end()) continue;
+
+            std::chrono::duration<double, std::micro> latency = clock_type::now() - start->second;
+            if (response.status == service::protocol::Status::Ok) {
+                report.latencies.push_back(latency.count());
+            } else {
+                report.errors++;
+            }
+            started.erase(start);
+            received++;
+        }
+        input.erase(0, input_offset);
+        input_offset = 0;
+    }
+
+    report.lost = options.requests - received;
+    close(fd);
+    return report;
+}
+
+double percentile(const std::vector<double>& sorted, double rank) {
+    if (sorted.empty()) return 0;
+    auto index = static_cast<std::size_t>(std::ceil(rank * sorted.size()));
+    return sorted[std::min(sorted.size() - 1, (index > 0) ? index - 1 : 0)];
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0]
+                  << " <socket path> [connections] [requests per connection] [points] [depth]"
+                     " [formula...]"
+                  << std::endl;
+        return 1;
+    }
+
+    ClientOptions options;
+    options.socket_path = argv[1];
+    if (argc > 2) options.connections = std::stoul(argv[2]);
+    if (argc > 3) options.requests = std::stoul(argv[3]);
+    if (argc > 4) options.points = std::stoul(argv[4]);
+    if (argc > 5) options.depth = std::max<std::size_t>(1, std::stoul(argv[5]));
+    if (argc > 6) options.formulas.assign(argv + 6, argv + argc);
+
+    std::vector<ClientReport> reports(options.connections);
+    std::vector<std::thread> clients;
+    auto start = clock_type::now();
+    for (std::size_t i = 0; i < options.connections; i++) {
+        clients.emplace_back([&options, &reports, i] {
+            try {
+                reports[i] = runClient(options, i);
+            } catch (const std::exception& e) {
+                std::cerr << e.what() << std::endl;
+                reports[i].lost = options.requests;
+            }
+        });
+    }
+    for (std::thread& client : clients) client.join();
+    std::chrono::duration<double> elapsed = clock_type::now() - start;
+
+    std::vector<double> latencies;
+    std::size_t errors = 0;
+    std::size_t lost = 0;
+    for (const ClientReport& report : reports) {
+        latencies.insert(latencies.end(), report.latencies.begin(), report.latencies.end());
+        errors += report.errors;
+        lost += report.lost;
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    // Error responses are cheap to produce, so only the successful ones count as throughput.
+    double throughput = latencies.size() / elapsed.count();
+    std::cout << "requests:   " << latencies.size() << " ok, " << errors << " errors, " << lost
+              << " lost" << std::endl
+              << "throughput: " << throughput << " requests/s, " << throughput * options.points
+              << " points/s" << std::endl
+              << "latency:    p50 " << percentile(latencies, 0.5) << " us, p99 "
+              << percentile(latencies, 0.99) << " us, max "
+              << (latencies.empty() ? 0 : latencies.back()) << " us" << std::endl;
+
+    return (errors == 0 && lost == 0) ? 0 : 1;
+}
@@ -0,0 +1,231 @@
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include "calculations.hpp"
+#include "evaluator.hpp"
+
+#ifndef __PLOTTING_HPP__
+#define __PLOTTING_HPP__
+
+namespace plotting {
+/// @brief  Tile of the plot: `index`-th span of x at the zoom `level` of the formula with
+/// `expression` hash.
+struct TileKey {
+    std::size_t expression;
+    int32_t level;
+    int64_t index;
+
+    bool operator==(const TileKey& compare) const {
+        return expression == compare.expression && level == compare.level &&
+               index == compare.index;
+    }
+};
+
+struct TileKeyHash {
+    std::size_t operator()(const TileKey& key) const noexcept {
+        std::size_t seed = key.expression;
+        for (std::size_t part :
+             {static_cast<std::size_t>(key.level), static_cast<std::size_t>(key.index)})
+            seed ^= part + 0x9e3779b97f4a7c15 + (seed << 6) + (seed >> 2);
+        return seed;
+    }
+};
+
+struct PlotSamples {
+    std::vector<double> x;
+    std::vector<double> y;
+};
+
+/// @brief  Cache of the evaluated plot samples. The x axis is split into tiles of
+/// `tile_samples` samples, the step of samples at level L is base_step * 2^L. Panning evaluates
+/// only the tiles which were not shown yet. A tile whose parent (the next coarser level) is
+/// cached evaluates only its odd samples, the even ones are the parent samples; a tile whose two
+/// children are cached is not evaluated at all. Tiles are evicted in LRU order once the memory
+/// budget is exceeded.
+class TileCache {
+    using lru_order = std::list<TileKey>;
+
+    struct Tile {
+        std::vector<double> samples;
+        lru_order::iterator position;
+    };
+
+    struct Formula {
+        std::string expression;
+        calculations::NotationEvaluator evaluator;
+    };
+
+private:
+    calculations::ClassicAlgebra algebra_;
+    std::unordered_map<std::size_t, Formula> formulas_;
+    std::unordered_map<TileKey, Tile, TileKeyHash> tiles_;
+    lru_order order_;
+    std::size_t tile_samples_;
+    double base_step_;
+    std::size_t capacity_;
+    std::size_t evaluated_ = 0;
+
+    double step(int32_t level) const noexcept { return std::ldexp(base_step_, level); }
+
+    double sampleX(const TileKey& key, std::size_t sample) const noexcept {
+        return static_cast<double>(key.index * static_cast<int64_t>(tile_samples_) +
+                                   static_cast<int64_t>(sample)) *
+               step(key.level);
+    }
+
+    static int64_t parentIndex(int64_t index) noexcept {
+        return (index < 0) ? -((1 - index) / 2) : index / 2;
+    }
+
+    const std::vector<double>* find(const TileKey& key) {
+        auto tile = tiles_.find(key);
+        if (tile == tiles_.end()) return nullptr;
+
+        order_.splice(order_.begin(), order_, tile->second.position);
+        return &tile->second.samples;
+    }
+
+    /// @brief  Evaluates the samples of `tile` which are listed in `samples` indices.
+    void evaluateSamples(const Formula& formula, const TileKey& key,
+                         const std::vector<std::size_t>& samples, std::vector<double>& tile) {
+        std::vector<double> x(samples.size());
+        for (std::size_t i = 0; i < samples.size(); i++) x[i] = sampleX(key, samples[i]);
+
+        std::vector<double> y;
+        formula.evaluator.evaluate(x.data(), x.size(), y);
+        for (std::size_t i = 0; i < samples.size(); i++) tile[samples[i]] = y[i];
+        evaluated_ += samples.size();
+    }
+
+    const std::vector<double>& tile(const Formula& formula, const TileKey& key) {
+        if (const std::vector<double>* cached = find(key)) return *cached;
+
+        std::size_t half = tile_samples_ / 2;
+        std::vector<double> samples(tile_samples_);
+        std::vector<std::size_t> missing;
+
+        int64_t parent_index = parentIndex(key.index);
+        const std::vector<double>* parent = find({key.expression, key.level + 1, parent_index});
+        const std::vector<double>* left = find({key.expression, key.level - 1, 2 * key.index});
+        const std::vector<double>* right =
+            (left) ? find({key.expression, key.level - 1, 2 * key.index + 1}) : nullptr;
+
+        if (parent) {
+            std::size_t offset = (key.index != 2 * parent_index) ? half : 0;
+            for (std::size_t i = 0; i < half; i++) {
+                samples[2 * i] = (*parent)[offset + i];
+                missing.push_back(2 * i + 1);
+            }
+        } else if (left && right) {
+            for (std::size_t i = 0; i < half; i++) {
+                samples[i] = (*left)[2 * i];
+                samples[half + i] = (*right)[2 * i];
+            }
+        } else {
+            for (std::size_t i = 0; i < tile_samples_; i++) missing.push_back(i);
+        }
+        if (!missing.empty()) evaluateSamples(formula, key, missing, samples);
+
+        order_.push_front(key);
+        auto inserted = tiles_.emplace(key, Tile{std::move(samples), order_.begin()}).first;
+
+        while (tiles_.size() > capacity_) {
+            tiles_.erase(order_.back());
+            order_.pop_back();
+        }
+
+        return inserted->second.samples;
+    }
+
+    const Formula& formula(const std::string& expression) {
+        std::size_t hash = std::hash<std::string>()(expression);
+        auto found = formulas_.find(hash);
+        if (found != formulas_.end() && found->second.expression == expression)
+            return found->second;
+
+        if (found != formulas_.end()) {
+            dropFormula(hash);
+            formulas_.erase(found);
+        }
+
+        Formula compiled{expression, calculations::NotationEvaluator(expression, algebra_)};
+        return formulas_.emplace(hash, std::move(compiled)).first->second;
+    }
+
+    void dropFormula(std::size_t hash) {
+        for (auto key = order_.begin(); key != order_.end();) {
+            if (key->expression == hash) {
+                tiles_.erase(*key);
+                key = order_.erase(key);
+            } else {
+                key++;
+            }
+        }
+    }
+
+public:
+    /// @brief  `tile_samples` must be even, `base_step` should be a power of two for the shared
+    /// samples of neighbouring levels to have exactly the same x.
+    TileCache(std::size_t tile_samples = 256, double base_step = 1.0 / 1024,
+              std::size_t memory_budget = 64 << 20)
+        : tile_samples_(tile_samples),
+          base_step_(base_step),
+          capacity_(std::max<std::size_t>(1, memory_budget / (tile_samples * sizeof(double)))) {
+        if (tile_samples == 0 || tile_samples % 2 != 0 || !(base_step > 0)) {
+            throw std::logic_error("Invalid tile cache parameters\n");
+        }
+        algebra_.initializeRulesInterface();
+    }
+
+    /// @brief  Samples of `expression` on [x_min, x_max] at the finest level whose step is not
+    /// coarser than (x_max - x_min) / resolution.
+    PlotSamples plot(const std::string& expression, double x_min, double x_max,
+                     std::size_t resolution) {
+        if (!(x_min < x_max) || resolution == 0) {
+            throw std::logic_error("Invalid plot viewport\n");
+        }
+
+        const Formula& compiled = formula(expression);
+        std::size_t hash = std::hash<std::string>()(expression);
+        auto level = static_cast<int32_t>(
+            std::floor(std::log2((x_max - x_min) / static_cast<double>(resolution) / base_step_)));
+        double width = step(level) * static_cast<double>(tile_samples_);
+
+        PlotSamples result;
+        auto last = static_cast<int64_t>(std::floor(x_max / width));
+        for (auto index = static_cast<int64_t>(std::floor(x_min / width)); index <= last; index++) {
+            TileKey key{hash, level, index};
+            const std::vector<double>& samples = tile(compiled, key);
+
+            for (std::size_t i = 0; i < tile_samples_; i++) {
+                double x = sampleX(key, i);
+                if (x < x_min || x > x_max) continue;
+                result.x.push_back(x);
+                result.y.push_back(samples[i]);
+            }
+        }
+
+        return result;
+    }
+
+    void clear() {
+        tiles_.clear();
+        order_.clear();
+        formulas_.clear();
+    }
+
+    std::size_t size() const noexcept { return tiles_.size(); }
+    std::size_t capacity() const noexcept { return capacity_; }
+
+    /// @brief  Quantity of the samples evaluated since the cache creation.
+    std::size_t evaluated() const noexcept { return evaluated_; }
+};
+}  // namespace plotting
+
+#endif  // __PLOTTING_HPP__
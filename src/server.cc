@@ -0,0 +1,43 @@
+#include <csignal>
+#include <iostream>
+#include <string>
+
+#include "server.hpp"
+
+namespace {
+service::EvaluationServer* running_server = nullptr;
+
+void stopServer(int) {
+    if (running_server) running_server->stop();
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <socket path> [workers] [queue capacity]"
+                  << std::endl;
+        return 1;
+    }
+
+    try {
+        service::ServerOptions options;
+        options.socket_path = argv[1];
+        if (argc > 2) options.workers = std::stoul(argv[2]);
+        if (argc > 3) options.queue_capacity = std::stoul(argv[3]);
+
+        service::EvaluationServer server(options);
+        running_server = &server;
+        std::signal(SIGINT, stopServer);
+        std::signal(SIGTERM, stopServer);
+
+        std::cout << "Listening on " << options.socket_path << " with " << options.workers
+                  << " workers" << std::endl;
+        server.run();
+        running_server = nullptr;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,676 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "calculations.hpp"
+#include "evaluator.hpp"
+
+#ifndef __SERVER_HPP__
+#define __SERVER_HPP__
+
+namespace service {
+namespace exceptions {
+class SystemException : public std::exception {
+    std::string message;
+
+public:
+    SystemException(const char* call) : message(std::string(call) + ": " + std::strerror(errno)) {}
+
+    const char* what() const noexcept { return message.c_str(); }
+};
+}  // namespace exceptions
+
+/// @brief  Frames of the local socket protocol. Every frame is a uint32 payload length followed
+/// by the payload, all numbers are in the host byte order.
+/// Request payload:  uint64 id, uint32 formula length, formula, uint32 quantity, double x[].
+/// Response payload: uint64 id, uint8 status, then uint32 quantity, double y[] for Status::Ok or
+/// uint32 message length, message for Status::Error.
+namespace protocol {
+inline constexpr uint32_t max_frame_size = 64 << 20;
+
+enum class Status : uint8_t { Ok = 0, Error = 1 };
+
+struct Request {
+    uint64_t id;
+    std::string formula;
+    std::vector<double> x;
+};
+
+struct Response {
+    uint64_t id;
+    Status status;
+    std::vector<double> y;
+    std::string message;
+};
+
+template <typename T>
+void put(std::string& buffer, const T& value) {
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+inline void putDoubles(std::string& buffer, const double* values, std::size_t quantity) {
+    put(buffer, static_cast<uint32_t>(quantity));
+    buffer.append(reinterpret_cast<const char*>(values), quantity * sizeof(double));
+}
+
+inline void putString(std::string& buffer, std::string_view text) {
+    put(buffer, static_cast<uint32_t>(text.size()));
+    buffer.append(text);
+}
+
+/// @brief  Reads values of the payload, throws if the payload is shorter than expected.
+class Reader {
+    std::string_view payload_;
+
+    std::string_view take(std::size_t size) {
+        if (payload_.size() < size) throw std::logic_error("Truncated frame\n");
+        std::string_view taken = payload_.substr(0, size);
+        payload_.remove_prefix(size);
+        return taken;
+    }
+
+public:
+    Reader(std::string_view payload) : payload_(payload) {}
+
+    template <typename T>
+    T get() {
+        T value;
+        std::memcpy(&value, take(sizeof(T)).data(), sizeof(T));
+        return value;
+    }
+
+    std::vector<double> getDoubles() {
+        std::size_t quantity = get<uint32_t>();
+        std::string_view data = take(quantity * sizeof(double));
+        std::vector<double> values(quantity);
+        std::memcpy(values.data(), data.data(), data.size());
+        return values;
+    }
+
+    std::string getString() { return std::string(take(get<uint32_t>())); }
+};
+
+/// @brief  Appends the frame with the payload written by `write` to the buffer.
+template <typename Writer>
+void appendFrame(std::string& buffer, Writer write) {
+    std::size_t header = buffer.size();
+    put(buffer, uint32_t{0});
+    write(buffer);
+
+    auto size = static_cast<uint32_t>(buffer.size() - header - sizeof(uint32_t));
+    std::memcpy(buffer.data() + header, &size, sizeof(uint32_t));
+}
+
+/// @brief  Returns the payload of the first complete frame of `buffer` starting at `offset` and
+/// moves `offset` behind it.
+inline std::optional<std::string_view> nextFrame(const std::string& buffer, std::size_t& offset) {
+    if (buffer.size() - offset < sizeof(uint32_t)) return std::nullopt;
+
+    uint32_t size;
+    std::memcpy(&size, buffer.data() + offset, sizeof(uint32_t));
+    if (size > max_frame_size) throw std::logic_error("Frame is too large\n");
+    if (buffer.size() - offset - sizeof(uint32_t) < size) return std::nullopt;
+
+    std::string_view payload(buffer.data() + offset + sizeof(uint32_t), size);
+    offset += sizeof(uint32_t) + size;
+    return payload;
+}
+
+inline void appendRequest(std::string& buffer, const Request& request) {
+    appendFrame(buffer, [&](std::string& payload) {
+        put(payload, request.id);
+        putString(payload, request.formula);
+        putDoubles(payload, request.x.data(), request.x.size());
+    });
+}
+
+inline Request parseRequest(std::string_view payload) {
+    Reader reader(payload);
+    Request request;
+    request.id = reader.get<uint64_t>();
+    request.formula = reader.getString();
+    request.x = reader.getDoubles();
+    return request;
+}
+
+inline Response parseResponse(std::string_view payload) {
+    Reader reader(payload);
+    Response response;
+    response.id = reader.get<uint64_t>();
+    response.status = reader.get<Status>();
+    if (response.status == Status::Ok) {
+        response.y = reader.getDoubles();
+    } else {
+        response.message = reader.getString();
+    }
+    return response;
+}
+
+inline sockaddr_un socketAddress(const std::string& path) {
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) {
+        throw std::logic_error("Socket path is too long\n");
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return address;
+}
+}  // namespace protocol
+
+struct ServerOptions {
+    std::string socket_path;
+    std::size_t workers = std::max(1u, std::thread::hardware_concurrency());
+    /// @brief  Requests queued or being evaluated, reading from clients pauses above it.
+    std::size_t queue_capacity = 4096;
+    /// @brief  Unsent responses of a connection, reading from it pauses above it.
+    std::size_t output_limit = 16 << 20;
+};
+
+/// @brief  Evaluation server on a Unix domain socket. One epoll event loop serves all connections
+/// and a fixed pool of workers evaluates the formulas. Requests for the same formula which wait
+/// in the queue are coalesced into one batch and evaluated with one NotationEvaluator call.
+class EvaluationServer {
+    static constexpr uint64_t listener_id = 0;
+    static constexpr uint64_t wakeup_id = 1;
+    static constexpr std::size_t read_chunk = 64 << 10;
+    static constexpr std::size_t compiled_capacity = 1024;
+    static constexpr std::size_t max_batch_points = 1 << 20;
+
+    struct Connection {
+        int fd;
+        std::string input;
+        std::size_t input_offset = 0;
+        std::string output;
+        std::size_t output_offset = 0;
+        uint32_t events = 0;
+        /// @brief  Requests of the connection which are not answered yet.
+        std::size_t pending = 0;
+        /// @brief  The client shut down its side, the connection closes once it is answered.
+        bool input_closed = false;
+        /// @brief  Complete frames wait in the input until the queue has room for them.
+        bool backlogged = false;
+    };
+
+    struct Part {
+        uint64_t connection;
+        uint64_t request;
+        std::size_t quantity;
+    };
+
+    struct Batch {
+        std::string formula;
+        std::vector<double> x;
+        std::vector<Part> parts;
+    };
+
+    struct Completion {
+        uint64_t connection;
+        std::string frames;
+        std::size_t responses = 0;
+    };
+
+private:
+    ServerOptions options_;
+    calculations::ClassicAlgebra algebra_;
+
+    int listener_ = -1;
+    int epoll_ = -1;
+    int wakeup_ = -1;
+    /// @brief  Descriptor reserved to refuse a client when the descriptors run out.
+    int spare_ = -1;
+    bool listener_paused_ = false;
+    std::atomic<bool> stopping_{false};
+
+    std::unordered_map<uint64_t, Connection> connections_;
+    uint64_t next_connection_ = wakeup_id + 1;
+    bool overloaded_ = false;
+    std::unordered_set<uint64_t> backlogged_;
+
+    std::mutex queue_mutex_;
+    std::condition_variable queue_ready_;
+    std::deque<std::unique_ptr<Batch>> queue_;
+    std::unordered_map<std::string, Batch*> open_batches_;
+    std::size_t in_flight_ = 0;
+
+    std::mutex completions_mutex_;
+    std::vector<Completion> completions_;
+
+    std::mutex compiled_mutex_;
+    std::unordered_map<std::string, std::shared_ptr<const calculations::NotationEvaluator>>
+        compiled_;
+
+    std::vector<std::thread> workers_;
+
+    static void check(int result, const char* call) {
+        if (result < 0) throw exceptions::SystemException(call);
+    }
+
+    void watch(uint64_t id, int fd, uint32_t events, int operation) {
+        epoll_event event{};
+        event.events = events;
+        event.data.u64 = id;
+        check(epoll_ctl(epoll_, operation, fd, &event), "epoll_ctl");
+    }
+
+    void wake() {
+        uint64_t one = 1;
+        [[maybe_unused]] ssize_t written = write(wakeup_, &one, sizeof(one));
+    }
+
+    std::shared_ptr<const calculations::NotationEvaluator> compiled(const std::string& formula) {
+        std::lock_guard<std::mutex> lock(compiled_mutex_);
+        auto found = compiled_.find(formula);
+        if (found != compiled_.end()) return found->second;
+
+        if (compiled_.size() >= compiled_capacity) compiled_.clear();
+        auto evaluator = std::make_shared<const calculations::NotationEvaluator>(formula, algebra_);
+        compiled_.emplace(formula, evaluator);
+        return evaluator;
+    }
+
+    /// @brief  Evaluates the batch and splits the result into the responses of its parts.
+    std::vector<Completion> evaluate(const Batch& batch) {
+        std::vector<double> y;
+        std::string message;
+        try {
+            compiled(batch.formula)->evaluate(batch.x.data(), batch.x.size(), y);
+        } catch (const std::exception& e) {
+            message = e.what();
+        }
+
+        std::unordered_map<uint64_t, Completion> responses;
+        std::size_t offset = 0;
+        for (const Part& part : batch.parts) {
+            Completion& completion = responses[part.connection];
+            completion.connection = part.connection;
+            completion.responses++;
+            protocol::appendFrame(completion.frames, [&](std::string& payload) {
+                protocol::put(payload, part.request);
+                if (message.empty()) {
+                    protocol::put(payload, protocol::Status::Ok);
+                    protocol::putDoubles(payload, y.data() + offset, part.quantity);
+                } else {
+                    protocol::put(payload, protocol::Status::Error);
+                    protocol::putString(payload, message);
+                }
+            });
+            offset += part.quantity;
+        }
+
+        std::vector<Completion> completions;
+        for (auto& [connection, completion] : responses)
+            completions.push_back(std::move(completion));
+        return completions;
+    }
+
+    void work() {
+        while (true) {
+            std::unique_ptr<Batch> batch;
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex_);
+                queue_ready_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+                if (queue_.empty()) return;
+
+                batch = std::move(queue_.front());
+                queue_.pop_front();
+                auto open = open_batches_.find(batch->formula);
+                if (open != open_batches_.end() && open->second == batch.get())
+                    open_batches_.erase(open);
+            }
+
+            std::vector<Completion> completions = evaluate(*batch);
+
+            // The event loop checks the backpressure after it is woken up, so release the queue
+            // capacity first.
+            {
+                std::lock_guard<std::mutex> lock(queue_mutex_);
+                in_flight_ -= batch->parts.size();
+            }
+            {
+                std::lock_guard<std::mutex> lock(completions_mutex_);
+                for (Completion& completion : completions)
+                    completions_.push_back(std::move(completion));
+            }
+            wake();
+        }
+    }
+
+    /// @brief  Joins the request to the queued batch of its formula or queues a new batch.
+    void enqueue(uint64_t connection, protocol::Request&& request) {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        Part part{connection, request.id, request.x.size()};
+        in_flight_++;
+
+        auto open = open_batches_.find(request.formula);
+        if (open != open_batches_.end() &&
+            open->second->x.size() + request.x.size() <= max_batch_points) {
+            Batch& batch = *open->second;
+            batch.x.insert(batch.x.end(), request.x.begin(), request.x.end());
+            batch.parts.push_back(part);
+            return;
+        }
+
+        auto batch = std::make_unique<Batch>(
+            Batch{std::move(request.formula), std::move(request.x), {part}});
+        open_batches_[batch->formula] = batch.get();
+        queue_.push_back(std::move(batch));
+        queue_ready_.notify_one();
+    }
+
+    void updateEvents(uint64_t id, Connection& connection) {
+        uint32_t events = 0;
+        std::size_t unsent = connection.output.size() - connection.output_offset;
+        if (!overloaded_ && !connection.input_closed && unsent < options_.output_limit)
+            events |= EPOLLIN;
+        if (unsent != 0) events |= EPOLLOUT;
+
+        if (events != connection.events) {
+            watch(id, connection.fd, events, EPOLL_CTL_MOD);
+            connection.events = events;
+        }
+    }
+
+    void setOverloaded(bool overloaded) {
+        if (overloaded == overloaded_) return;
+
+        overloaded_ = overloaded;
+        for (auto& [id, connection] : connections_) updateEvents(id, connection);
+    }
+
+    /// @brief  Pauses or resumes reading from all the connections when the queue fills or drains.
+    /// On resume the frames already buffered in the backlogged connections are queued first, as
+    /// no EPOLLIN comes for the data which is read already.
+    void applyBackpressure() {
+        bool overloaded;
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            overloaded = (overloaded_) ? in_flight_ > options_.queue_capacity / 2
+                                       : in_flight_ >= options_.queue_capacity;
+        }
+        setOverloaded(overloaded);
+
+        std::vector<uint64_t> backlog(backlogged_.begin(), backlogged_.end());
+        for (auto id = backlog.begin(); !overloaded_ && id != backlog.end(); id++) {
+            auto found = connections_.find(*id);
+            if (found == connections_.end()) continue;
+
+            if (!parse(*id, found->second) || finished(found->second)) {
+                close(*id);
+            } else {
+                updateEvents(*id, found->second);
+            }
+        }
+    }
+
+    /// @brief  Out of descriptors the pending client keeps the level triggered listener ready, so
+    /// it is accepted on the reserved descriptor and closed at once. Without the reserved
+    /// descriptor the listener is not watched until a connection closes.
+    void refuse() {
+        if (spare_ >= 0) {
+            ::close(spare_);
+            int fd = accept4(listener_, nullptr, nullptr, SOCK_CLOEXEC);
+            if (fd >= 0) ::close(fd);
+            spare_ = open("/dev/null", O_RDONLY | O_CLOEXEC);
+        }
+
+        if (spare_ < 0) {
+            watch(listener_id, listener_, 0, EPOLL_CTL_MOD);
+            listener_paused_ = true;
+        }
+    }
+
+    void accept() {
+        while (true) {
+            int fd = accept4(listener_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) return;
+                if (errno == ECONNABORTED) continue;
+                if (errno == EMFILE || errno == ENFILE) return refuse();
+                throw exceptions::SystemException("accept4");
+            }
+
+            uint64_t id = next_connection_++;
+            Connection& connection = connections_[id];
+            connection.fd = fd;
+            connection.events = (overloaded_) ? 0 : static_cast<uint32_t>(EPOLLIN);
+            watch(id, fd, connection.events, EPOLL_CTL_ADD);
+        }
+    }
+
+    void close(uint64_t id) {
+        auto connection = connections_.find(id);
+        if (connection == connections_.end()) return;
+
+        epoll_ctl(epoll_, EPOLL_CTL_DEL, connection->second.fd, nullptr);
+        ::close(connection->second.fd);
+        connections_.erase(connection);
+        backlogged_.erase(id);
+
+        if (spare_ < 0) spare_ = open("/dev/null", O_RDONLY | O_CLOEXEC);
+        if (listener_paused_) {
+            watch(listener_id, listener_, EPOLLIN, EPOLL_CTL_MOD);
+            listener_paused_ = false;
+        }
+    }
+
+    static bool finished(const Connection& connection) {
+        return connection.input_closed && !connection.backlogged && connection.pending == 0 &&
+               connection.output_offset == connection.output.size();
+    }
+
+    /// @brief  Queues the complete frames of the input while the queue has room, the rest stays
+    /// buffered until the load drops. Returns false if the connection has to be closed.
+    bool parse(uint64_t id, Connection& connection) {
+        connection.backlogged = false;
+        try {
+            std::size_t offset = connection.input_offset;
+            while (auto payload = protocol::nextFrame(connection.input, offset)) {
+                {
+                    std::lock_guard<std::mutex> lock(queue_mutex_);
+                    connection.backlogged = in_flight_ >= options_.queue_capacity;
+                }
+                if (connection.backlogged) break;
+
+                enqueue(id, protocol::parseRequest(*payload));
+                connection.input_offset = offset;
+                connection.pending++;
+            }
+        } catch (const std::exception&) {
+            // Malformed data of one client must not stop the server.
+            return false;
+        }
+
+        connection.input.erase(0, connection.input_offset);
+        connection.input_offset = 0;
+
+        if (connection.backlogged) {
+            backlogged_.insert(id);
+            setOverloaded(true);
+        } else {
+            backlogged_.erase(id);
+        }
+        return true;
+    }
+
+    /// @brief  Reads one chunk per readiness event, so a pipelining client can not fill the input
+    /// buffer past the queue. Returns false if the connection has to be closed.
+    bool receive(uint64_t id, Connection& connection) {
+        char chunk[read_chunk];
+        ssize_t received = recv(connection.fd, chunk, sizeof(chunk), 0);
+        if (received < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+
+        connection.input.append(chunk, received);
+        // The requests sent before the shutdown are still answered.
+        if (received == 0) connection.input_closed = true;
+
+        return parse(id, connection);
+    }
+
+    /// @brief  Returns false if the connection has to be closed.
+    bool send(Connection& connection) {
+        while (connection.output_offset < connection.output.size()) {
+            const char* unsent = connection.output.data() + connection.output_offset;
+            std::size_t length = connection.output.size() - connection.output_offset;
+            ssize_t sent = ::send(connection.fd, unsent, length, MSG_NOSIGNAL);
+            if (sent < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+            connection.output_offset += sent;
+        }
+
+        connection.output.clear();
+        connection.output_offset = 0;
+        return true;
+    }
+
+    void deliverCompletions() {
+        uint64_t counter;
+        [[maybe_unused]] ssize_t drained = read(wakeup_, &counter, sizeof(counter));
+
+        std::vector<Completion> completions;
+        {
+            std::lock_guard<std::mutex> lock(completions_mutex_);
+            completions.swap(completions_);
+        }
+
+        for (Completion& completion : completions) {
+            auto found = connections_.find(completion.connection);
+            if (found == connections_.end()) continue;
+
+            Connection& connection = found->second;
+            connection.output += completion.frames;
+            connection.pending -= completion.responses;
+            if (!send(connection) || finished(connection)) {
+                close(completion.connection);
+            } else {
+                updateEvents(completion.connection, connection);
+            }
+        }
+    }
+
+    void release() {
+        for (auto& [id, connection] : connections_) ::close(connection.fd);
+        connections_.clear();
+        if (listener_ >= 0) {
+            ::close(listener_);
+            unlink(options_.socket_path.c_str());
+        }
+        if (epoll_ >= 0) ::close(epoll_);
+        if (wakeup_ >= 0) ::close(wakeup_);
+        if (spare_ >= 0) ::close(spare_);
+        listener_ = epoll_ = wakeup_ = spare_ = -1;
+    }
+
+public:
+    EvaluationServer(const ServerOptions& options) : options_(options) {
+        if (options_.workers == 0 || options_.queue_capacity == 0) {
+            throw std::logic_error("Invalid server options\n");
+        }
+        algebra_.initializeRulesInterface();
+
+        try {
+            sockaddr_un address = protocol::socketAddress(options_.socket_path);
+            unlink(options_.socket_path.c_str());
+
+            check(listener_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0),
+                  "socket");
+            check(bind(listener_, reinterpret_cast<sockaddr*>(&address), sizeof(address)),
+                  "bind");
+            check(listen(listener_, SOMAXCONN), "listen");
+            check(epoll_ = epoll_create1(EPOLL_CLOEXEC), "epoll_create1");
+            check(wakeup_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC), "eventfd");
+            check(spare_ = open("/dev/null", O_RDONLY | O_CLOEXEC), "open");
+
+            watch(listener_id, listener_, EPOLLIN, EPOLL_CTL_ADD);
+            watch(wakeup_id, wakeup_, EPOLLIN, EPOLL_CTL_ADD);
+        } catch (...) {
+            release();
+            throw;
+        }
+    }
+
+    EvaluationServer(const EvaluationServer&) = delete;
+    EvaluationServer(EvaluationServer&&) = delete;
+
+    ~EvaluationServer() {
+        stop();
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            queue_ready_.notify_all();
+        }
+        for (std::thread& worker : workers_)
+            if (worker.joinable()) worker.join();
+        release();
+    }
+
+    /// @brief  Serves the clients in the calling thread until stop() is called.
+    void run() {
+        for (std::size_t i = workers_.size(); i < options_.workers; i++)
+            workers_.emplace_back(&EvaluationServer::work, this);
+
+        std::vector<epoll_event> events(256);
+        while (!stopping_) {
+            int ready = epoll_wait(epoll_, events.data(), events.size(), -1);
+            if (ready < 0 && errno == EINTR) continue;
+            check(ready, "epoll_wait");
+
+            for (int i = 0; i < ready; i++) {
+                uint64_t id = events[i].data.u64;
+                if (id == listener_id) {
+                    accept();
+                    continue;
+                }
+                if (id == wakeup_id) {
+                    deliverCompletions();
+                    continue;
+                }
+
+                auto found = connections_.find(id);
+                if (found == connections_.end()) continue;
+                Connection& connection = found->second;
+
+                bool alive = !(events[i].events & (EPOLLERR | EPOLLHUP)) ||
+                             (events[i].events & EPOLLIN);
+                if (alive && (events[i].events & EPOLLIN)) alive = receive(id, connection);
+                if (alive && (events[i].events & EPOLLOUT)) alive = send(connection);
+
+                if (alive && !finished(connection)) {
+                    updateEvents(id, connection);
+                } else {
+                    close(id);
+                }
+            }
+
+            applyBackpressure();
+        }
+    }
+
+    /// @brief  Asks run() to return, safe to call from a signal handler.
+    void stop() {
+        stopping_ = true;
+        wake();
+    }
+};
+}  // namespace service
+
+#endif  // __SERVER_HPP__
@@ -0,0 +1,88 @@
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <vector>
+
+#include "server.hpp"
+
+namespace {
+std::size_t failures = 0;
+
+void check(bool condition, const std::string& description) {
+    if (!condition) {
+        std::cerr << "FAILED: " << description << std::endl;
+        failures++;
+    }
+}
+
+int connectTo(const std::string& path) {
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_un address = service::protocol::socketAddress(path);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        if (fd >= 0) close(fd);
+        throw service::exceptions::SystemException("connect");
+    }
+    return fd;
+}
+
+/// @brief  Sends the request on a new connection and waits for its response.
+service::protocol::Response request(const std::string& path, const std::string& formula,
+                                    const std::vector<double>& x) {
+    int fd = connectTo(path);
+    std::string output;
+    service::protocol::appendRequest(output, service::protocol::Request{7, formula, x});
+    for (std::size_t offset = 0; offset < output.size();) {
+        ssize_t sent = send(fd, output.data() + offset, output.size() - offset, MSG_NOSIGNAL);
+        if (sent <= 0) break;
+        offset += sent;
+    }
+
+    std::string input;
+    std::size_t input_offset = 0;
+    char chunk[64 << 10];
+    while (true) {
+        if (auto payload = service::protocol::nextFrame(input, input_offset)) {
+            close(fd);
+            return service::protocol::parseResponse(*payload);
+        }
+        ssize_t size = recv(fd, chunk, sizeof(chunk), 0);
+        if (size <= 0) break;
+        input.append(chunk, size);
+    }
+
+    close(fd);
+    throw std::logic_error("Connection closed without a response\n");
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    service::ServerOptions options;
+    options.socket_path = (argc > 1) ? argv[1] : "/tmp/evaluation-server-check.sock";
+    options.workers = 2;
+
+    try {
+        service::EvaluationServer server(options);
+        std::thread serving([&server] { server.run(); });
+
+        for (const std::string formula : {"x-1)(", ")x(", "x)+(1"}) {
+            service::protocol::Response response = request(options.socket_path, formula, {1, 2});
+            check(response.id == 7 && response.status == service::protocol::Status::Error,
+                  "\"" + formula + "\" is answered with an error");
+        }
+
+        service::protocol::Response response = request(options.socket_path, "(x-1)*2", {1, 2, 4});
+        check(response.status == service::protocol::Status::Ok && response.y.size() == 3 &&
+                  response.y[0] == 0 && response.y[1] == 2 && response.y[2] == 6,
+              "server keeps evaluating after malformed formulas");
+
+        server.stop();
+        serving.join();
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    if (failures == 0) std::cout << "All checks passed" << std::endl;
+    return (failures == 0) ? 0 : 1;
+}